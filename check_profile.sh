@@ -0,0 +1,51 @@
+#!/bin/sh
+# Regression check for --profile and the source lines tokens carry.
+# Usage: ./check_profile.sh <interpreter binary>
+set -u
+if [ $# -ne 1 ]; then
+    echo "Usage: $0 <interpreter binary>" >&2
+    exit 2
+fi
+bin=$1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+status=0
+
+fail() {
+    echo "FAIL: $1"
+    status=1
+}
+
+# Reports go next to the script, so profile a copy
+cp in21.py "$dir/in21.py"
+"$bin" --profile "$dir/in21.py" > "$dir/out.txt" 2> "$dir/err.txt" || fail "profiled run"
+cmp -s "$dir/out.txt" out21.txt || fail "output under --profile differs from out21.txt"
+[ -s "$dir/in21.py.lines" ] || fail "no .lines report"
+[ -s "$dir/in21.py.folded" ] || fail "no .folded report"
+
+# "owner:line" for every statement line of the script: top level lines (def included) belong to
+# <module>, indented lines to the function above them
+awk '/^[ \t]*$/ || /^[ \t]*#/ { next }
+     /^def / { name = $2; sub(/\(.*/, "", name); print "<module>:" NR; next }
+     /^[ \t]/ { print name ":" NR; next }
+     { print "<module>:" NR }' in21.py > "$dir/statements.txt"
+
+# Every line charged must be a statement line
+while read -r line count; do
+    grep -q ":$line\$" "$dir/statements.txt" || fail ".lines charges line $line, which is not a statement"
+done < "$dir/in21.py.lines"
+
+# Every stack must be <module>:N;fn:M... count, with each line inside the function it names
+grep -v -E '^<module>:[0-9]+(;[A-Za-z_][A-Za-z0-9_]*:[0-9]+)* [0-9]+$' "$dir/in21.py.folded" > "$dir/bad.txt"
+[ -s "$dir/bad.txt" ] && fail "malformed .folded stacks: $(cat "$dir/bad.txt")"
+for frame in $(cut -d' ' -f1 "$dir/in21.py.folded" | tr ';' '\n' | sort -u); do
+    grep -qx "$frame" "$dir/statements.txt" || fail ".folded frame $frame is not a statement of that function"
+done
+
+# Both reports count the same samples
+lineTotal=$(awk '{ sum += $2 } END { print sum }' "$dir/in21.py.lines")
+foldedTotal=$(awk '{ sum += $NF } END { print sum }' "$dir/in21.py.folded")
+[ "$lineTotal" = "$foldedTotal" ] || fail ".lines counts $lineTotal samples but .folded counts $foldedTotal"
+
+[ $status -eq 0 ] && echo "profile checks passed"
+exit $status
@@ -0,0 +1,41 @@
+#!/bin/sh
+# Regression check for --save-snapshot / --load-snapshot.
+# Usage: ./check_snapshot.sh <interpreter binary>
+set -u
+if [ $# -ne 1 ]; then
+    echo "Usage: $0 <interpreter binary>" >&2
+    exit 2
+fi
+bin=$1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+status=0
+
+fail() {
+    echo "FAIL: $1"
+    status=1
+}
+
+# Save the setup state, then run on top of it
+"$bin" --save-snapshot "$dir/state.snap" in16_setup.py > /dev/null || fail "saving snapshot"
+"$bin" --load-snapshot "$dir/state.snap" in16.py > "$dir/out.txt" 2>&1
+cmp -s "$dir/out.txt" out16.txt || fail "output after load differs from out16.txt"
+
+# Re-saving over the mapped file must carry every function and variable forward, and must replace
+# the file rather than rewrite it, since other processes may have the old one mapped
+before=$(ls -i "$dir/state.snap")
+"$bin" --load-snapshot "$dir/state.snap" --save-snapshot "$dir/state.snap" in16.py > /dev/null 2>&1 || fail "re-saving snapshot in place"
+[ "$(ls -i "$dir/state.snap")" != "$before" ] || fail "snapshot rewritten in place instead of replaced"
+[ ! -e "$dir/state.snap.tmp" ] || fail "temporary snapshot file left behind"
+"$bin" --load-snapshot "$dir/state.snap" in16.py > "$dir/out.txt" 2>&1
+cmp -s "$dir/out.txt" out16.txt || fail "output after in-place re-save differs from out16.txt"
+
+# Damaged and missing files must be rejected with an error, not a crash
+head -c 100 "$dir/state.snap" > "$dir/truncated.snap"
+"$bin" --load-snapshot "$dir/truncated.snap" in16.py > "$dir/out.txt" 2>&1
+[ $? -eq 1 ] && grep -q "wrong format" "$dir/out.txt" || fail "truncated snapshot not rejected"
+"$bin" --load-snapshot "$dir/missing.snap" in16.py > "$dir/out.txt" 2>&1
+[ $? -eq 1 ] && grep -q "Could not open snapshot" "$dir/out.txt" || fail "missing snapshot not reported"
+
+[ $status -eq 0 ] && echo "snapshot checks passed"
+exit $status
@@ -0,0 +1,27 @@
+# Test Case for: recursive and tail recursive functions
+
+def fact(n):
+    if n <= 1:
+        return 1
+    r = fact(n - 1)
+    return n * r
+
+def depth(n):
+    if n == 0:
+        return 0
+    d = depth(n - 1)
+    return d + 1
+
+def sumTo(n, acc):
+    if n == 0:
+        return acc
+    else:
+        return sumTo(n - 1, acc + n)
+
+resA = fact(10)
+resB = depth(20000)
+resC = sumTo(50000, 0)
+
+print("resA =", resA)
+print("resB =", resB)
+print("resC =", resC)
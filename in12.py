@@ -0,0 +1,11 @@
+# Test Case for: values beyond 32 bits and division
+
+a = 3000000
+b = a * a
+c = b / 7
+d = 100
+e = d - 100
+f = c / d
+print("b =", b)
+print("c =", c)
+print("f =", f)
@@ -0,0 +1,31 @@
+# Test Case for: calls inside expressions and non-tail recursion
+
+def dbl(n):
+    if n == 0:
+        return 0
+    return dbl(n - 1) * 2 + 5
+
+def fact(n):
+    factor = n
+    if factor <= 1:
+        return 1
+    return fact(n - 1) * factor
+
+def hh(n):
+    return n + 1
+
+def f(n):
+    if n == 0:
+        return 7
+    f(n - 1)
+    return f(n - 1)
+
+resA = dbl(3)
+resB = fact(10) + fact(3)
+resC = hh(hh(1)) + 100
+resD = f(4)
+
+print("resA =", resA)
+print("resB =", resB)
+print("resC =", resC)
+print("resD =", resD)
@@ -0,0 +1,14 @@
+# Test Case for: a division check that range analysis must keep
+# Expected output is the error the interpreter reports (on stderr)
+
+def safeDiv(a, b):
+    d = 1
+    if b == 0:
+        d = 0
+    return a / d
+
+resA = safeDiv(10, 2)
+resB = safeDiv(10, 0)
+
+print("resA =", resA)
+print("resB =", resB)
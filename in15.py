@@ -0,0 +1,7 @@
+# Test Case for: an overflow check that range analysis must keep
+# Expected output is the error the interpreter reports (on stderr)
+
+a = 3000000
+b = a * a * a
+
+print("b =", b)
@@ -0,0 +1,9 @@
+# Test Case for: state restored from a snapshot of in16_setup.py
+
+resA = fact(base)
+resB = big + 1
+resC = wide / 1000
+
+print("resA =", resA)
+print("resB =", resB)
+print("resC =", resC)
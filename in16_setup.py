@@ -0,0 +1,15 @@
+# Setup for in16.py: run with --save-snapshot, then run in16.py with --load-snapshot
+
+def fact(n):
+    if n <= 1:
+        return 1
+    return fact(n - 1) * n
+
+def addTo(n, acc):
+    if n == 0:
+        return acc
+    return addTo(n - 1, acc + n)
+
+base = 7
+big = addTo(1000, 0)
+wide = 3000000 * 3000000
@@ -0,0 +1,22 @@
+# Test Case for: names that start with a keyword are not keywords
+
+def noreturn(n):
+    return n + 1
+
+def early_return(n):
+    noreturn(n)
+    return n * 10
+
+def f(n):
+    return n - 3
+
+x = 8
+iffy = f(x)
+elsewhere = iffy + 1
+printed = early_return(4)
+returned = noreturn(iffy)
+
+print("iffy =", iffy)
+print("elsewhere =", elsewhere)
+print("printed =", printed)
+print("returned =", returned)
@@ -0,0 +1,19 @@
+# Test Case for: top-level calls whose result is discarded
+
+def show(n):
+    x = n * 2
+    print("shown =", x)
+    return x
+
+def countdown(n):
+    if n == 0:
+        print("done =", n)
+        return 0
+    return countdown(n - 1)
+
+y = 3
+show(5)
+show(y + 1)
+countdown(y)
+
+print("y =", y)
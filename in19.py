@@ -0,0 +1,12 @@
+# Test Case for: call temporaries do not clash with script variables
+
+def sq(n):
+    return n * n
+
+tmp__0 = 5
+tmp__1 = 6
+total = sq(3) + sq(4) + tmp__0
+
+print("tmp__0 =", tmp__0)
+print("tmp__1 =", tmp__1)
+print("total =", total)
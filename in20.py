@@ -0,0 +1,9 @@
+# Test Case for: '$' is reserved for call temporaries
+
+def sq(n):
+    return n * n
+
+$0 = 5
+total = sq(3) + 1
+
+print("total =", total)
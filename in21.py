@@ -0,0 +1,13 @@
+# Test Case for: a hot loop to profile, see check_profile.sh
+
+def inc(x):
+    return x + 1
+
+def loop(n, acc):
+    if n == 0:
+        return acc
+    total = inc(acc)
+    return loop(n - 1, total)
+
+res = loop(1000000, 0)
+print("res =", res)
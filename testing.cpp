@@ -8,6 +8,18 @@
 #include <cctype>  // for std::iscntrl
 #include <stack>
 #include <algorithm> 
+#include <atomic>
+#include <map>
+#include <csignal>
+#include <sys/time.h>  // setitimer for the sampling profiler
+#include <sys/mman.h>  // mmap for snapshots
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <cstdio>  // std::rename for snapshots
 
 enum class TokenType {
     ID, NUM, ASSIGN, PRINT, STRING, SEMICOLON, END, COMMENT, 
@@ -22,16 +34,111 @@ struct Token { // Debugging: Defined a struct for tokens
     TokenType type; // Debugging: Added a member for token type
     std::string value; // Debugging: Added a member for token value
     int indent_level; // Added to track indentation level
+    int line; // 1-based source line, 0 for synthesized tokens
+    int column; // 1-based column of the first non-blank character
 
-        Token(TokenType type, std::string value, int indent_level)
-        : type(type), value(value), indent_level(indent_level) {}
+        Token(TokenType type, std::string value, int indent_level, int line = 0, int column = 0)
+        : type(type), value(value), indent_level(indent_level), line(line), column(column) {}
 };
 
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+// True if statement starts with keyword as a whole word, so "return x" matches but "noreturn(x)" and "iffy = 1" do not
+bool startsWithKeyword(const std::string& statement, const std::string& keyword) {
+    if (statement.compare(0, keyword.size(), keyword) != 0) {
+        return false;
+    }
+    return statement.size() == keyword.size() || !(std::isalnum(statement[keyword.size()]) || statement[keyword.size()] == '_');
+}
+
+// Splits "name(a, b)" into its name and comma separated arguments. Returns false unless text is
+// exactly one call: balanced parentheses with the closing one as the last non-blank character.
+bool splitCall(const std::string& text, std::string& name, std::vector<std::string>& arguments) {
+    size_t openParenthesisPos = text.find('(');
+    size_t closeParenthesisPos = text.find_last_not_of(" \t");
+    if (openParenthesisPos == std::string::npos || closeParenthesisPos == std::string::npos || text[closeParenthesisPos] != ')') {
+        return false;
+    }
+    int depth = 0;
+    for (size_t i = openParenthesisPos; i <= closeParenthesisPos; ++i) {
+        if (text[i] == '(') {
+            ++depth;
+        } else if (text[i] == ')' && --depth == 0 && i != closeParenthesisPos) {
+            return false;  // The call ends before the text does, e.g. "f(x) * 2"
+        }
+    }
+    if (depth != 0) {
+        return false;
+    }
+    name = trim(text.substr(0, openParenthesisPos));
+    if (name.empty() || !std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(c) || c == '_'; })) {
+        return false;
+    }
+
+    arguments.clear();
+    std::string argumentList = text.substr(openParenthesisPos + 1, closeParenthesisPos - openParenthesisPos - 1);
+    if (trim(argumentList).empty()) {
+        return true;
+    }
+    std::istringstream iss(argumentList);
+    std::string argument;
+    while (std::getline(iss, argument, ',')) {
+        arguments.push_back(trim(argument));
+    }
+    return true;
+}
+
+// Temporaries made by hoistCalls() are named "$N"; the tokenizer rejects '$' outside strings, so
+// these names can never clash with a script variable
+bool isTemporary(const std::string& name) {
+    return name.size() > 1 && name[0] == '$' && std::all_of(name.begin() + 1, name.end(), [](char c) { return std::isdigit(c); });
+}
+
+// Replaces each call nested inside expression with a temporary and emits an ASSIGNMENT_FUNCTION_CALL
+// token for it first, innermost call first, so "return f(n - 1) * n" still runs on the call stack.
+// With keepOuterCall, an expression that is exactly one call is left alone (a direct or tail call).
+std::string hoistCalls(std::string expression, bool keepOuterCall, std::vector<Token>& tokens, int indentLevel, int line, int column, int& temporaryCount) {
+    while (true) {
+        size_t closeParenthesisPos = expression.find(')');
+        if (closeParenthesisPos == std::string::npos) {
+            break;
+        }
+        size_t openParenthesisPos = expression.rfind('(', closeParenthesisPos);
+        if (openParenthesisPos == std::string::npos) {
+            break;
+        }
+        size_t nameStart = openParenthesisPos;
+        while (nameStart > 0 && (std::isalnum(expression[nameStart - 1]) || expression[nameStart - 1] == '_')) {
+            --nameStart;
+        }
+        if (nameStart == openParenthesisPos) {
+            break;  // Plain parentheses are not supported; compileExpression() reports them
+        }
+        std::string call = expression.substr(nameStart, closeParenthesisPos - nameStart + 1);
+        if (keepOuterCall && trim(expression) == call) {
+            break;
+        }
+        std::string temporary = "$" + std::to_string(temporaryCount++);
+        tokens.emplace_back(TokenType::ASSIGNMENT_FUNCTION_CALL, temporary + " = " + call, indentLevel, line, column);
+        expression.replace(nameStart, call.size(), temporary);
+    }
+    return expression;
+}
+
+using Value = int64_t;  // Script integers are stored as 64-bit values
+
 class FunctionDefNode;
 class ASTNode {
 public:
     virtual ~ASTNode() = default;
-    virtual void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) = 0;
+    virtual void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) = 0;
     virtual std::string toString() const = 0;  // Pure virtual function
 };
 
@@ -47,7 +154,7 @@ public:
         return "FunctionCallNode: " + functionName + "(" + arguments + ")";
     }
 
-            void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+            void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
 
         // Implementation of evaluate for FunctionCallNode
         // This will depend on how you've implemented your language
@@ -57,14 +164,15 @@ public:
 class FunctionDefNode : public ASTNode {
 public:
     std::string name;
+    std::vector<std::string> parameters;
     std::vector<Token> bodyTokens;
-FunctionDefNode(const std::string& name, const std::vector<Token>& bodyTokens) : name(name), bodyTokens(bodyTokens) {}
+FunctionDefNode(const std::string& name, const std::vector<std::string>& parameters, const std::vector<Token>& bodyTokens) : name(name), parameters(parameters), bodyTokens(bodyTokens) {}
     std::string toString() const override {
         return "FunctionDefNode: " + name + "(" + /* replace this with the string representation of bodyTokens */ + ")";
     }
 
 
-            void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+            void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
 
         // Implementation of evaluate for FunctionCallNode
         // This will depend on how you've implemented your language
@@ -72,24 +180,316 @@ FunctionDefNode(const std::string& name, const std::vector<Token>& bodyTokens) :
 };
 
 
+// Sampling profiler. SIGPROF only raises a flag; the interpreter loop checks it as each instruction
+// finishes and charges that instruction, copying the script call stack into a lock-free single
+// producer ring buffer.
+class Profiler {
+public:
+    static const int kMaxSampleDepth = 64;
+
+    struct Sample {
+        int depth;  // Frames used, outermost first
+        int lines[kMaxSampleDepth];
+        const FunctionDefNode* functions[kMaxSampleDepth];  // nullptr for the top level script
+        bool truncated;  // Middle frames were dropped to fit kMaxSampleDepth
+    };
+
+    static std::atomic<bool> sampleRequested;
+
+    void start(int intervalMicroseconds) {
+        ring.resize(4096);  // ~3 MB, so only allocated when profiling
+        std::signal(SIGPROF, [](int) { sampleRequested.store(true, std::memory_order_relaxed); });
+        itimerval timer{};
+        timer.it_interval.tv_usec = intervalMicroseconds;
+        timer.it_value.tv_usec = intervalMicroseconds;
+        setitimer(ITIMER_PROF, &timer, nullptr);
+    }
+
+    void stop() {
+        itimerval timer{};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        std::signal(SIGPROF, SIG_IGN);
+        drain();
+    }
+
+    // Cheap enough to call on every instruction
+    bool sampleDue() const { return sampleRequested.load(std::memory_order_relaxed); }
+
+    Sample& beginSample() {
+        sampleRequested.store(false, std::memory_order_relaxed);
+        size_t head = ringHead.load(std::memory_order_relaxed);
+        if (head - ringTail.load(std::memory_order_acquire) == ring.size()) {
+            drain();  // Full: fold the oldest samples into the totals before overwriting them
+        }
+        return ring[head % ring.size()];
+    }
+
+    void commitSample() { ringHead.fetch_add(1, std::memory_order_release); }
+
+    void writeReport(const std::string& basePath) {
+        drain();
+        std::ofstream lines(basePath + ".lines");
+        for (const auto& entry : lineHits) {
+            lines << entry.first << " " << entry.second << "\n";
+        }
+        std::ofstream folded(basePath + ".folded");
+        for (const auto& entry : stackHits) {
+            folded << entry.first << " " << entry.second << "\n";
+        }
+        std::cerr << "Profile: " << totalSamples << " samples written to " << basePath << ".lines and " << basePath << ".folded\n";
+    }
+
+private:
+    std::vector<Sample> ring;
+    std::atomic<size_t> ringHead{0};  // Next slot the interpreter writes
+    std::atomic<size_t> ringTail{0};  // Next slot drain() reads
+    std::map<int, long> lineHits;  // Source line of the innermost frame -> samples
+    std::map<std::string, long> stackHits;  // Collapsed "outer;inner" stack -> samples
+    long totalSamples = 0;
+
+    void drain() {
+        size_t head = ringHead.load(std::memory_order_acquire);
+        size_t tail = ringTail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            const Sample& sample = ring[tail % ring.size()];
+            std::string stack;
+            for (int i = 0; i < sample.depth; ++i) {
+                if (i > 0) {
+                    stack += ';';
+                }
+                if (i == 1 && sample.truncated) {
+                    stack += "[truncated];";
+                }
+                stack += (sample.functions[i] ? sample.functions[i]->name : std::string("<module>")) + ":" + std::to_string(sample.lines[i]);
+            }
+            ++stackHits[stack];
+            ++lineHits[sample.lines[sample.depth - 1]];
+            ++totalSamples;
+        }
+        ringTail.store(tail, std::memory_order_release);
+    }
+};
+
+std::atomic<bool> Profiler::sampleRequested{false};
+
+// Snapshot file layout. Every reference is a byte offset from the start of the file, so the
+// file can be mapped at any address and used in place.
+struct SnapshotString {
+    uint64_t offset;
+    uint64_t length;
+};
+
+struct SnapshotHeader {
+    char magic[8];  // "PYSNAP\0\0"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t variableCount;
+    uint64_t variablesOffset;  // SnapshotVariable[variableCount]
+    uint64_t functionCount;
+    uint64_t functionsOffset;  // SnapshotFunction[functionCount], sorted by name
+};
+
+struct SnapshotVariable {
+    SnapshotString name;
+    int64_t value;
+};
+
+struct SnapshotFunction {
+    SnapshotString name;
+    uint64_t parameterCount;
+    uint64_t parametersOffset;  // SnapshotString[parameterCount]
+    uint64_t tokenCount;
+    uint64_t tokensOffset;  // SnapshotToken[tokenCount]
+};
+
+struct SnapshotToken {
+    int32_t type;
+    int32_t indentLevel;
+    int32_t line;
+    int32_t column;
+    SnapshotString value;
+};
+
+const char kSnapshotMagic[8] = {'P', 'Y', 'S', 'N', 'A', 'P', 0, 0};
+const uint32_t kSnapshotVersion = 1;
+
+// A snapshot file mapped copy-on-write. Functions are read straight out of the mapping on demand.
+class Snapshot {
+    const char* base = nullptr;
+    size_t size = 0;
+
+    template <typename T>
+    const T* at(uint64_t offset, uint64_t count) const {
+        if (offset > size || count > (size - offset) / sizeof(T)) {
+            throw std::runtime_error("Corrupt snapshot: reference outside the file.");
+        }
+        return reinterpret_cast<const T*>(base + offset);
+    }
+
+public:
+    explicit Snapshot(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open snapshot " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Snapshot " + path + " is too small.");
+        }
+        size = st.st_size;
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps the file alive
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Could not map snapshot " + path);
+        }
+        base = static_cast<const char*>(mapping);
+
+        const SnapshotHeader& h = header();
+        if (std::memcmp(h.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || h.version != kSnapshotVersion || h.fileSize != size) {
+            munmap(const_cast<char*>(base), size);
+            throw std::runtime_error("Snapshot " + path + " has the wrong format or version.");
+        }
+    }
+
+    ~Snapshot() {
+        munmap(const_cast<char*>(base), size);
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(base); }
+
+    std::string str(const SnapshotString& ref) const { return std::string(at<char>(ref.offset, ref.length), ref.length); }
+
+    const SnapshotVariable* variables() const { return at<SnapshotVariable>(header().variablesOffset, header().variableCount); }
+
+    const SnapshotFunction* functions() const { return at<SnapshotFunction>(header().functionsOffset, header().functionCount); }
+
+    // Binary search over the sorted function table
+    const SnapshotFunction* findFunction(const std::string& name) const {
+        const SnapshotFunction* table = functions();
+        size_t low = 0, high = header().functionCount;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            const SnapshotString& ref = table[mid].name;
+            int cmp = name.compare(0, std::string::npos, at<char>(ref.offset, ref.length), ref.length);
+            if (cmp == 0) {
+                return &table[mid];
+            }
+            if (cmp < 0) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<FunctionDefNode> loadFunction(const SnapshotFunction& function) const {
+        std::vector<std::string> parameters;
+        const SnapshotString* parameterRefs = at<SnapshotString>(function.parametersOffset, function.parameterCount);
+        for (uint64_t i = 0; i < function.parameterCount; ++i) {
+            parameters.push_back(str(parameterRefs[i]));
+        }
+        std::vector<Token> bodyTokens;
+        const SnapshotToken* tokenRefs = at<SnapshotToken>(function.tokensOffset, function.tokenCount);
+        for (uint64_t i = 0; i < function.tokenCount; ++i) {
+            const SnapshotToken& t = tokenRefs[i];
+            bodyTokens.emplace_back(static_cast<TokenType>(t.type), str(t.value), t.indentLevel, t.line, t.column);
+        }
+        return std::make_unique<FunctionDefNode>(str(function.name), parameters, bodyTokens);
+    }
+};
+
+// One step of a compiled expression, in postfix order
+struct Instruction {
+    enum Kind { PUSH_CONSTANT, PUSH_VARIABLE, APPLY_OPERATOR } kind;
+    Value constant;
+    std::string variable;
+    TokenType op;
+    bool checkDivisionByZero;  // Cleared by range analysis when the divisor cannot be 0
+    bool checkOverflow;  // Cleared by range analysis when the result always fits in a Value
+};
+
+struct CompiledExpression {
+    std::vector<Instruction> code;
+    size_t maxDepth = 0;  // Deepest operand stack the code reaches
+    std::string error;  // Set when the expression is malformed; thrown when it is evaluated
+};
+
+// The expressions one token evaluates, compiled once and reused on every execution
+struct CompiledToken {
+    std::vector<CompiledExpression> expressions;
+    std::string comparison;  // IF only: "==", "<", ... or empty for a plain truth test
+    std::string callee;  // Calls and tail calls: the function named, empty otherwise
+    std::string returnTarget;  // ASSIGNMENT_FUNCTION_CALL only: the variable that receives the result
+    FunctionDefNode* function = nullptr;  // callee once resolved, see Interpreter::resolveCallee()
+};
+
+// Static counts of the runtime checks range analysis removed, for --check-stats
+struct CheckStats {
+    long divisionChecks = 0, divisionChecksRemoved = 0;
+    long operandChecks = 0, operandChecksRemoved = 0;
+    long overflowChecks = 0, overflowChecksRemoved = 0;
+};
+
+// One script-level call. Frames live on Interpreter::callStack (heap) instead of the C++ stack.
+struct CallFrame {
+    FunctionDefNode* function;
+    size_t pc;  // Index of the next body token to execute
+    std::unordered_map<std::string, Value> locals;
+    std::string returnTarget;  // Caller variable that receives the result, empty to discard it
+};
 
 class Interpreter {
     std::string current_token;
-    std::stack<std::unordered_map<std::string, int>> scopes;
+    std::stack<std::unordered_map<std::string, Value>> scopes;
     std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>> functions;
-    int returnValue;
+    Value returnValue;
     std::string returnVariable;
+    std::vector<CallFrame> callStack;
+    size_t maxCallDepth = 100000;  // Each frame is a few hundred bytes, so this is the memory budget for recursion
+    Profiler* profiler = nullptr;
+    std::unique_ptr<Snapshot> snapshot;  // Functions not yet materialized are looked up here
+    std::unordered_map<const Token*, CompiledToken> compiledTokens;
+    CheckStats checkStats;
+    const Token* currentStatement = nullptr;  // Top level token being executed, for profiler samples
+    int temporaries = 0;  // Temporaries created by hoistCalls(), numbered across every tokenize() call
+
+    void pushFrame(FunctionDefNode* function, const std::vector<Value>& arguments, const std::string& returnTarget);
+    void bindArguments(CallFrame& frame, FunctionDefNode* function, const std::vector<Value>& arguments);
+    Value runCallStack(size_t baseDepth);
+    void recordSample(const FunctionDefNode* function, const Token& token, size_t depth);
+    void analyzeScope(const std::vector<const Token*>& tokens, const std::unordered_map<std::string, Value>& initialValues, const std::vector<std::string>& parameters, int unconditionalIndent);
 
 public:
     
     std::stack<FunctionCallNode*> functionCallStack;
 
-   std::unique_ptr<FunctionDefNode> createFunctionDefNode(const std::string& name, const std::vector<Token>& tokens) {
-    return std::make_unique<FunctionDefNode>(name, tokens);
+   std::unique_ptr<FunctionDefNode> createFunctionDefNode(const std::string& name, const std::vector<std::string>& parameters, const std::vector<Token>& tokens) {
+    return std::make_unique<FunctionDefNode>(name, parameters, tokens);
 }
 
+    void setMaxCallDepth(size_t depth) { maxCallDepth = depth; }
+
+    int& temporaryCount() { return temporaries; }
+
+    void setProfiler(Profiler* p) { profiler = p; }
+
+    // Called by parseProgram around each top level token
+    void beginStatement(const Token& token) { currentStatement = &token; }
+
+    void endStatement(const Token& token) {
+        if (profiler != nullptr && profiler->sampleDue()) {
+            recordSample(nullptr, token, 0);
+        }
+    }
+
     void enterScope() {
-        scopes.push(std::unordered_map<std::string, int>());
+        scopes.push(std::unordered_map<std::string, Value>());
     }
 
     void leaveScope() {
@@ -98,7 +498,7 @@ public:
         }
     }
     
-    int getVariable(const std::string& name) {
+    Value getVariable(const std::string& name) {
         if (!scopes.empty() && scopes.top().count(name) > 0) {
             return scopes.top().at(name);
         }
@@ -112,12 +512,24 @@ public:
 
     std::string getCurrentToken() { return current_token; }
 
-    int evaluate(const std::string& expression) {
-        // TODO: Implement expression evaluation
-        return 0;
-    }
+    CompiledToken& compiled(const Token& token);
+
+    // Looks up the callee of a call token on its first run and keeps it with the compiled token
+    FunctionDefNode* resolveCallee(CompiledToken& compiledToken);
+
+    // Evaluates the index-th expression of token, see expressionSources()
+    Value evaluate(const Token& token, size_t index, std::unordered_map<std::string, Value>& context);
 
-    void setReturnValue(int value) {
+    std::vector<Value> evaluateArguments(const Token& token, std::unordered_map<std::string, Value>& context);
+    std::vector<Value> evaluateArguments(const CompiledToken& compiledToken, std::unordered_map<std::string, Value>& context);
+
+    // Range analysis over the top level tokens and every function defined so far
+    void analyzeProgram(const std::vector<Token>& tokens, const std::unordered_map<std::string, Value>& context);
+    void analyzeFunction(const FunctionDefNode& function);
+
+    const CheckStats& getCheckStats() const { return checkStats; }
+
+    void setReturnValue(Value value) {
         returnValue = value;
     }
 
@@ -125,23 +537,35 @@ public:
         returnVariable = variable;
     }
 
-    int getReturnVariableValue() {
+    Value getReturnVariableValue() {
         if (scopes.top().count(returnVariable) == 0) {
             throw std::runtime_error("Return variable not found: " + returnVariable);
         }
         return scopes.top().at(returnVariable);
     }
 
-    int callFunction(const std::string& functionName) {
-        if (functions.count(functionName) == 0) {
-            throw std::runtime_error("Function not found: " + functionName);
+    FunctionDefNode* findFunction(const std::string& functionName) {
+        auto it = functions.find(functionName);
+        if (it != functions.end()) {
+            return it->second.get();
         }
-
-        // Call the function and return the result
-        functions[functionName]->evaluate(scopes, functions);
-        return getReturnVariableValue();
+        // Materialize snapshot functions on first use so restoring costs only the mmap
+        const SnapshotFunction* stored = snapshot ? snapshot->findFunction(functionName) : nullptr;
+        if (stored == nullptr) {
+            return nullptr;
+        }
+        FunctionDefNode* function = snapshot->loadFunction(*stored).release();
+        functions[functionName].reset(function);
+        analyzeFunction(*function);
+        return function;
     }
 
+    void loadSnapshot(const std::string& path, std::unordered_map<std::string, Value>& context);
+    void saveSnapshot(const std::string& path, const std::unordered_map<std::string, Value>& context);
+
+    // Runs the call a top level ASSIGNMENT_FUNCTION_CALL or FUNCTION_CALL token makes and returns its result
+    Value callToken(const Token& token, std::unordered_map<std::string, Value>& context);
+
 
 
 void parseFunctionDef(std::vector<std::string>& tokens, Interpreter& interpreter) {
@@ -165,8 +589,10 @@ void parseFunctionCall(const Token& token) {
 
 
 void parseFunctionDef(const std::vector<Token>& tokens, Interpreter& interpreter) {
-    // Assuming the first token is the function name
+    // Assuming the first token is the function header, e.g. "name(a, b):"
     std::string functionName = tokens[0].value;
+    std::vector<std::string> parameters;
+    splitCall(functionName.substr(0, functionName.rfind(')') + 1), functionName, parameters);
 
     // Create a vector of Tokens for the body
     std::vector<Token> bodyTokens;
@@ -174,7 +600,7 @@ void parseFunctionDef(const std::vector<Token>& tokens, Interpreter& interpreter
         bodyTokens.push_back(*it);
     }
 
-    std::unique_ptr<FunctionDefNode> node = std::make_unique<FunctionDefNode>(functionName, bodyTokens);
+    std::unique_ptr<FunctionDefNode> node = std::make_unique<FunctionDefNode>(functionName, parameters, bodyTokens);
     interpreter.addFunction(functionName, std::move(node));
 }
 
@@ -183,7 +609,7 @@ class VariableNode : public ASTNode {
     std::string name;
 public:
     VariableNode(const std::string& n) : name(n) {}
-    void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+    void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
         if (contexts.empty()) {
             throw std::runtime_error("No context available in variable node .");
         }
@@ -202,10 +628,10 @@ class PrintNode : public ASTNode {
 public:
     PrintNode(std::vector<std::unique_ptr<ASTNode>> parts) : parts(std::move(parts)) {}
 
-    void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+    void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
     for (auto& part : parts) {
         part->evaluate(contexts, functions);
-        int result = contexts.top()["__expr_result"];
+        Value result = contexts.top()["__expr_result"];
         //std::cout << result << " ";
     }
     //std::cout << std::endl;
@@ -225,7 +651,7 @@ public:
     IfNode(std::unique_ptr<ASTNode> cond, std::vector<std::unique_ptr<ASTNode>> ifBlk, std::vector<std::unique_ptr<ASTNode>> elseBlk)
         : condition(std::move(cond)), ifBlock(std::move(ifBlk)), elseBlock(std::move(elseBlk)) {}
 
-    void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+    void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
     if (contexts.empty()) {
         throw std::runtime_error("No context available.");
     }
@@ -245,7 +671,7 @@ class AssignmentNode : public ASTNode {
     std::unique_ptr<ASTNode> value;
 public:
     AssignmentNode(const std::string& n, std::unique_ptr<ASTNode> v) : name(n), value(std::move(v)) {}
-    void evaluate(std::stack<std::unordered_map<std::string, int>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
+    void evaluate(std::stack<std::unordered_map<std::string, Value>>& contexts, std::unordered_map<std::string, std::unique_ptr<FunctionDefNode>>& functions) override {
     if (contexts.empty()) {
         throw std::runtime_error("No context available.");
     }
@@ -287,8 +713,22 @@ std::vector<Token> tokenize(const std::string& input, Interpreter& interpreter)
     int currentIndentLevel = 0;  // Keep track of the current indentation level
     int indentSize = -1;  // The number of spaces that represent one indent level
     std::string currentFunctionName;  // Keep track of the current function name
+    std::vector<std::string> currentParameters;
+    size_t functionStart = 0;  // Index of the FUNCTION_DEF token whose body is being collected
+    int functionIndent = -1;  // Indent level of that def, -1 when not inside a function
+
+    // Moves the collected body tokens out of the main stream and into a FunctionDefNode
+    auto closeFunction = [&]() {
+        std::vector<Token> functionTokens(tokens.begin() + functionStart + 1, tokens.end());
+        tokens.erase(tokens.begin() + functionStart + 1, tokens.end());
+        interpreter.addFunction(currentFunctionName, interpreter.createFunctionDefNode(currentFunctionName, currentParameters, functionTokens));
+        functionIndent = -1;
+    };
+
+    int lineNumber = 0;  // 1-based source line of the current line
 
     while (std::getline(iss, line)) {
+        ++lineNumber;
         while (!line.empty() && std::iscntrl(line.back())) {
             line.pop_back();  // Remove trailing control character
         }
@@ -309,47 +749,86 @@ std::vector<Token> tokenize(const std::string& input, Interpreter& interpreter)
         if (indentSize != -1 && indentSize != 0) {  // Check if indentSize is not zero before division
             currentIndentLevel = indentLevel / indentSize;  // Calculate the current indent level
         }
-        if (line.substr(indentLevel, 3) == "def") {
-    std::string functionName = line.substr(indentLevel + 4);  // Extract the function name
-    tokens.emplace_back(TokenType::FUNCTION_DEF, functionName, currentIndentLevel);  // Emplace the def token with the function name as its value
-    //std::cout << "\nEmplacing def with name: " << functionName << "\nIndent level: " << currentIndentLevel << "\n";
-    currentFunctionName = functionName;  // Assign the current function name
+        if (functionIndent != -1 && currentIndentLevel <= functionIndent) {
+            closeFunction();  // Dedented back out of the function body
+        }
+        std::string statement = line.substr(indentLevel);
+        bool isIf = startsWithKeyword(statement, "if");
+        bool isElse = startsWithKeyword(statement, "else");
+        bool isBranch = isIf || isElse;
+        bool isDef = startsWithKeyword(statement, "def");
+        bool isPrint = startsWithKeyword(statement, "print");
+        bool isReturn = startsWithKeyword(statement, "return");
+        if (!isPrint && statement.find('$') != std::string::npos) {
+            throw std::runtime_error("Unexpected character '$' on line " + std::to_string(lineNumber) + ": " + statement);
+        }
+        if (!isDef && !isPrint && !isElse) {
+            // Split off the expression part and move any calls nested in it onto their own lines
+            size_t expressionStart = 0;
+            bool keepOuterCall = true;
+            if (isIf) {
+                expressionStart = 2;
+                keepOuterCall = false;
+            } else if (isReturn) {
+                expressionStart = 6;
+            } else if (statement.find('=') != std::string::npos) {
+                expressionStart = statement.find('=') + 1;
+            }
+            statement = statement.substr(0, expressionStart) +
+                        hoistCalls(statement.substr(expressionStart), keepOuterCall, tokens, currentIndentLevel, lineNumber, indentLevel + 1, interpreter.temporaryCount());
+            line = line.substr(0, indentLevel) + statement;
+        }
+        std::string callName;
+        std::vector<std::string> callArguments;
+        size_t equalsPos = statement.find('=');
 
-    // Create a FunctionDefNode from tokens
-    std::vector<Token> functionTokens(tokens.begin() + 1, tokens.end()); // Assuming the function name is the first token
-    std::unique_ptr<FunctionDefNode> functionDefNode = interpreter.createFunctionDefNode(functionName, functionTokens);
+        if (isDef) {
+    if (functionIndent != -1) {
+        throw std::runtime_error("Nested function definitions are not supported: " + line);
+    }
+    std::string functionName = line.substr(indentLevel + 4);  // Extract the function header
+    tokens.emplace_back(TokenType::FUNCTION_DEF, functionName, currentIndentLevel, lineNumber, indentLevel + 1);  // Emplace the def token with the function header as its value
+    //std::cout << "\nEmplacing def with name: " << functionName << "\nIndent level: " << currentIndentLevel << "\n";
+    if (!splitCall(functionName.substr(0, functionName.rfind(')') + 1), currentFunctionName, currentParameters)) {
+        throw std::runtime_error("Invalid function definition: " + line);
+    }
 
-    // Add function to the interpreter
-    interpreter.addFunction(functionName, std::move(functionDefNode));
+    // The body tokens are collected until the indentation drops back to this level
+    functionStart = tokens.size() - 1;
+    functionIndent = currentIndentLevel;
 }
-        else if (line.substr(indentLevel, 5) == "print") {
-            tokens.emplace_back(TokenType::PRINT, line, currentIndentLevel);
+        else if (isPrint) {
+            tokens.emplace_back(TokenType::PRINT, line, currentIndentLevel, lineNumber, indentLevel + 1);
             //std::cout << "Emplacing PRINT token with value: " << line << std::endl;
         } 
-        else if (line.find('(') != std::string::npos && line.find(')') != std::string::npos && line.find('=') != std::string::npos) {
-            tokens.emplace_back(TokenType::ASSIGNMENT_FUNCTION_CALL, line, currentIndentLevel);  // Emplace the assignment function call token with the entire line as its value
+        else if (!isBranch && !isReturn && equalsPos != std::string::npos && splitCall(statement.substr(equalsPos + 1), callName, callArguments)) {
+            tokens.emplace_back(TokenType::ASSIGNMENT_FUNCTION_CALL, line, currentIndentLevel, lineNumber, indentLevel + 1);  // Emplace the assignment function call token with the entire line as its value
             //std::cout << "\nEmplacing ASSIGNMENT_FUNCTION_CALL token with value: " << line << "\nIndent level: " << currentIndentLevel << "\n";
-        } else if (line.find('=') != std::string::npos && !(line.substr(indentLevel, 2) == "if" or line.substr(indentLevel, 4) == "else")) {
-            tokens.emplace_back(TokenType::ASSIGN, line, currentIndentLevel);
+        } else if (line.find('=') != std::string::npos && !isBranch && !isReturn) {
+            tokens.emplace_back(TokenType::ASSIGN, line, currentIndentLevel, lineNumber, indentLevel + 1);
             // std::cout << "\nEmplacing ASSIGNMENT token with value: " << line << "\nIndent level: " << currentIndentLevel << "\n";
         }
-        else if (line.find("return") != std::string::npos) {
-            tokens.emplace_back(TokenType::RETURN, line, currentIndentLevel);  // Emplace the return token with the entire line as its value
+        else if (isReturn) {
+            tokens.emplace_back(TokenType::RETURN, line, currentIndentLevel, lineNumber, indentLevel + 1);  // Emplace the return token with the entire line as its value
             //std::cout << "\nEmplacing RETURN token with value: " << line << "\nIndent level: " << currentIndentLevel << "\n";
-        } else if (line.find(currentFunctionName) != std::string::npos) {
-            tokens.emplace_back(TokenType::FUNCTION_CALL, line, currentIndentLevel);  // Emplace the function call token with the entire line as its value
+        } else if (!isBranch && splitCall(statement, callName, callArguments)) {
+            tokens.emplace_back(TokenType::FUNCTION_CALL, line, currentIndentLevel, lineNumber, indentLevel + 1);  // Emplace the function call token with the entire line as its value
             //std::cout << "\nEmplacing FUNCTION_CALL token with value: " << line << "\nIndent level: " << currentIndentLevel << "\n";
         } 
-        if (line.substr(indentLevel, 2) == "if") {
-            tokens.emplace_back(TokenType::IF, line, currentIndentLevel);
+        if (isIf) {
+            tokens.emplace_back(TokenType::IF, line, currentIndentLevel, lineNumber, indentLevel + 1);
             //std::cout << "\nEmplacing IF token with value: " << line << "\nIndent level: " << currentIndentLevel << "\n";
-        } else if (line.substr(indentLevel, 4) == "else") {
-            tokens.emplace_back(TokenType::ELSE, "", currentIndentLevel);
+        } else if (isElse) {
+            tokens.emplace_back(TokenType::ELSE, "", currentIndentLevel, lineNumber, indentLevel + 1);
             //std::cout << "\nEmplacing ELSE token\nIndent level: " << currentIndentLevel << "\n";
         }
         
     }
 
+    if (functionIndent != -1) {
+        closeFunction();
+    }
+
     //std::cout << "\nEmplacing END token\n";
     tokens.emplace_back(TokenType::END, "", 0);
     //std::cout << "\nFinished tokenizing\n";
@@ -373,29 +852,29 @@ int precedence(TokenType op) {
 }
 
 
-void processOperator(TokenType op, std::stack<int>& operands, std::unordered_map<std::string, int>& context, Interpreter& interpret) {
-    if (operands.size() < 2) {
-        int numOperands = operands.size();
-        //std::cout << "Debug: Current token is " << interpret.getCurrentToken() << std::endl;
-        //std::cout << "Debug: Value of val is " << context["val"] << std::endl;
-        std::cerr << "Error: Not enough operands for operator. Needed 2, found " << numOperands << std::endl;
-        throw std::runtime_error("Not enough operands for operator: " + std::to_string(static_cast<int>(op)) + ". Needed 2, found " + std::to_string(numOperands));
-    }
-    int right = operands.top(); operands.pop();
-    int left = operands.top(); operands.pop();
-
-    //std::cout << "Processing operator " << static_cast<int>(op) << " with operands " << left << " and " << right << std::endl;
-
-    switch (op) {
-        case TokenType::PLUS: operands.push(left + right); break;
-        case TokenType::MINUS: operands.push(left - right); break;
-        case TokenType::MULTIPLY: operands.push(left * right); break;
+Value processOperator(const Instruction& instruction, Value left, Value right) {
+    Value result;
+    switch (instruction.op) {
+        case TokenType::PLUS:
+            if (!instruction.checkOverflow) return left + right;
+            if (__builtin_add_overflow(left, right, &result)) throw std::runtime_error("Integer overflow in addition.");
+            return result;
+        case TokenType::MINUS:
+            if (!instruction.checkOverflow) return left - right;
+            if (__builtin_sub_overflow(left, right, &result)) throw std::runtime_error("Integer overflow in subtraction.");
+            return result;
+        case TokenType::MULTIPLY:
+            if (!instruction.checkOverflow) return left * right;
+            if (__builtin_mul_overflow(left, right, &result)) throw std::runtime_error("Integer overflow in multiplication.");
+            return result;
         case TokenType::DIVIDE:
-            if (right == 0) {
+            if (instruction.checkDivisionByZero && right == 0) {
                 throw std::runtime_error("Division by zero.");
             }
-            operands.push(left / right);
-            break;
+            if (instruction.checkOverflow && left == INT64_MIN && right == -1) {
+                throw std::runtime_error("Integer overflow in division.");
+            }
+            return left / right;
         default:
             throw std::runtime_error("Unsupported operator encountered.");
     }
@@ -405,19 +884,19 @@ void processOperator(TokenType op, std::stack<int>& operands, std::unordered_map
 
 
 
-void evaluateAssignment(const std::string& id, const std::string& expression, std::unordered_map<std::string, int>& context) {
+void evaluateAssignment(const std::string& id, const std::string& expression, std::unordered_map<std::string, Value>& context) {
     //std::cout << "Evaluating assignment: " << id << " = " << expression << std::endl;
 
     // Evaluate the expression and store the result in the context
     std::istringstream iss(expression);
-    int result = 0;
+    Value result = 0;
     iss >> result;
     context[id] = result;
 }
 
 
 
-int getVariableValue(const std::string& id, const std::unordered_map<std::string, int>& context) {
+Value getVariableValue(const std::string& id, const std::unordered_map<std::string, Value>& context) {
     auto it = context.find(id);
     if (it != context.end()) {
         return it->second;  // Directly use iterator to access the value
@@ -434,49 +913,104 @@ void parseEnd(const Token& token, Interpreter& interpreter) {
 }
 
 
-int evaluateExpression(const std::vector<std::string>& parts, std::unordered_map<std::string, int>& context, Interpreter& interpret) {
-    std::stack<int> operands;
+// Converts infix parts to postfix code. Operand counts are checked here, once, instead of on every evaluation.
+CompiledExpression compileExpression(const std::vector<std::string>& parts) {
+    CompiledExpression compiled;
     std::stack<TokenType> operators;
+    size_t depth = 0;
+
+    auto emitOperator = [&](TokenType op) {
+        if (!compiled.error.empty()) {
+            return;
+        }
+        if (depth < 2) {
+            compiled.error = "Not enough operands for operator: " + std::to_string(static_cast<int>(op)) + ". Needed 2, found " + std::to_string(depth);
+            return;
+        }
+        if (precedence(op) == 0) {
+            compiled.error = "Unsupported operator encountered.";
+            return;
+        }
+        --depth;
+        compiled.code.push_back(Instruction{Instruction::APPLY_OPERATOR, 0, "", op, true, true});
+    };
 
     for (const auto& part : parts) {
-        //std::cout << "Evaluating part: " << part << std::endl;
         if (isdigit(part[0])) {  // If the part is a number
-            operands.push(std::stoi(part));
-        } else if (isalpha(part[0])) {  // If the part is a variable
-            operands.push(context[part]);
+            Value constant = 0;
+            try {
+                size_t used = 0;
+                constant = std::stoll(part, &used);
+                if (used != part.size()) {
+                    compiled.error = "Invalid number in expression: " + part;
+                }
+            } catch (const std::out_of_range&) {
+                compiled.error = "Integer literal out of range: " + part;
+            }
+            if (!compiled.error.empty()) {
+                return compiled;
+            }
+            compiled.code.push_back(Instruction{Instruction::PUSH_CONSTANT, constant, "", TokenType::NUM, true, true});
+            compiled.maxDepth = std::max(compiled.maxDepth, ++depth);
+        } else if (isalpha(part[0]) || isTemporary(part)) {  // If the part is a variable
+            if (!isTemporary(part) && !std::all_of(part.begin(), part.end(), [](char c) { return std::isalnum(c) || c == '_'; })) {
+                compiled.error = "Unsupported term in expression: " + part;  // e.g. parentheses
+                return compiled;
+            }
+            compiled.code.push_back(Instruction{Instruction::PUSH_VARIABLE, 0, part, TokenType::ID, true, true});
+            compiled.maxDepth = std::max(compiled.maxDepth, ++depth);
         } else {  // If the part is an operator
             TokenType op = getTokenType(part[0]);
-            //std::cout << "Encountered operator: " << static_cast<int>(op) << std::endl;
             while (!operators.empty() && precedence(op) <= precedence(operators.top())) {
-                if (operands.size() < 2) {
-                    std::cerr << "Error: Not enough operands for operator. Needed 2, found " << operands.size() << std::endl;
-                    throw std::runtime_error("Not enough operands for operator operand is here: " + std::to_string(static_cast<int>(op)));
-                }
-                processOperator(operators.top(), operands, context, interpret);
+                emitOperator(operators.top());
                 operators.pop();
             }
             operators.push(op);
         }
     }
 
-            while (!operators.empty()) {
-        if (operands.size() < 2) {
-            int numOperands = operands.size();
-            std::cerr << "Error: Not enough operands for operator. Needed 2, found " << numOperands << std::endl;
-            throw std::runtime_error("Not enough operands for operator. Needed 2, found " + std::to_string(numOperands));
-        }
-        processOperator(operators.top(), operands, context, interpret);
+    while (!operators.empty()) {
+        emitOperator(operators.top());
         operators.pop();
     }
 
+    if (compiled.error.empty() && depth != 1) {
+        compiled.error = "Invalid expression: expected one operand after evaluation, found " + std::to_string(depth) + ".";
+    }
+    return compiled;
+}
+
 
+Value runExpression(const CompiledExpression& compiled, std::unordered_map<std::string, Value>& context) {
+    if (!compiled.error.empty()) {
+        throw std::runtime_error(compiled.error);
+    }
 
-    if (operands.size() != 1) {
-        std::cerr << "Error: Invalid expression. More than one operand left after evaluation." << std::endl;
-        throw std::runtime_error("Invalid expression: more than one operand left after evaluation.");
+    // compileExpression() proved the stack never underflows, so there are no operand count checks here
+    Value small[16] = {};
+    std::vector<Value> large;
+    Value* operands = small;
+    if (compiled.maxDepth > 16) {
+        large.resize(compiled.maxDepth);
+        operands = large.data();
     }
 
-    return operands.top();
+    size_t top = 0;
+    for (const Instruction& instruction : compiled.code) {
+        switch (instruction.kind) {
+            case Instruction::PUSH_CONSTANT:
+                operands[top++] = instruction.constant;
+                break;
+            case Instruction::PUSH_VARIABLE:
+                operands[top++] = context[instruction.variable];
+                break;
+            case Instruction::APPLY_OPERATOR:
+                --top;
+                operands[top - 1] = processOperator(instruction, operands[top - 1], operands[top]);
+                break;
+        }
+    }
+    return operands[0];
 }
 
 
@@ -491,17 +1025,7 @@ bool isOperator(char c) {
 }
 
 
-void parseAssignment(const Token& token, std::unordered_map<std::string, int>& context, Interpreter& interpreter) {
-    std::string::size_type equalsPos = token.value.find('=');
-    if (equalsPos == std::string::npos) {
-        throw std::runtime_error("Invalid assignment format.");
-    }
-    std::string id = token.value.substr(0, equalsPos);
-    std::string expr = token.value.substr(equalsPos + 1);
-
-    // Remove any spaces from the variable name
-    id.erase(std::remove_if(id.begin(), id.end(), ::isspace), id.end());
-
+std::vector<std::string> splitExpression(const std::string& expr) {
     // Add spaces around the operators in the expression
     std::string spacedExpr;
     for (size_t i = 0; i < expr.size(); ++i) {
@@ -514,26 +1038,195 @@ void parseAssignment(const Token& token, std::unordered_map<std::string, int>& c
         }
     }
 
-    // Parse the expression and store the result in the context
     std::istringstream iss(spacedExpr);
     std::vector<std::string> parts;
     std::string part;
     while (iss >> part) {
         parts.push_back(part);
     }
+    return parts;
+}
+
+
+void parseAssignment(const Token& token, std::unordered_map<std::string, Value>& context, Interpreter& interpreter) {
+    std::string::size_type equalsPos = token.value.find('=');
+    if (equalsPos == std::string::npos) {
+        throw std::runtime_error("Invalid assignment format.");
+    }
+    std::string id = token.value.substr(0, equalsPos);
+    std::string expr = token.value.substr(equalsPos + 1);
 
-    // Evaluate the expression
-    int result = evaluateExpression(parts, context, interpreter);
+    // Remove any spaces from the variable name
+    id.erase(std::remove_if(id.begin(), id.end(), ::isspace), id.end());
+
+    // Evaluate the expression and store the result in the context
+    Value result = interpreter.evaluate(token, 0, context);
     context[id] = result;
 }
 
 
+bool evaluateCondition(const Token& token, std::unordered_map<std::string, Value>& context, Interpreter& interpreter) {
+    const std::string& comparison = interpreter.compiled(token).comparison;
+    if (comparison.empty()) {
+        return interpreter.evaluate(token, 0, context) != 0;
+    }
+    Value left = interpreter.evaluate(token, 0, context);
+    Value right = interpreter.evaluate(token, 1, context);
+    if (comparison == "==") return left == right;
+    if (comparison == "!=") return left != right;
+    if (comparison == "<=") return left <= right;
+    if (comparison == ">=") return left >= right;
+    if (comparison == "<") return left < right;
+    return left > right;
+}
+
+
+// Source text of the expressions a token evaluates, in the order the interpreter evaluates them.
+// Also fills in the comparison, callee and return target of compiled, which the interpreter would
+// otherwise have to parse out of the token text on every run.
+std::vector<std::string> expressionSources(const Token& token, CompiledToken& compiled) {
+    std::string& comparison = compiled.comparison;
+    std::string text = trim(token.value);
+    std::string functionName;
+    std::vector<std::string> arguments;
+
+    switch (token.type) {
+        case TokenType::ASSIGN:
+            return {text.substr(text.find('=') + 1)};
+        case TokenType::IF: {
+            // Strip the leading "if" and the trailing ':'
+            if (text.substr(0, 2) == "if") {
+                text = text.substr(2);
+            }
+            if (!text.empty() && text.back() == ':') {
+                text.pop_back();
+            }
+            // Two character operators first so "<=" is not read as "<"
+            static const std::vector<std::string> comparisons = {"==", "!=", "<=", ">=", "<", ">"};
+            for (const std::string& candidate : comparisons) {
+                size_t pos = text.find(candidate);
+                if (pos != std::string::npos) {
+                    comparison = candidate;
+                    return {text.substr(0, pos), text.substr(pos + candidate.size())};
+                }
+            }
+            return {text};
+        }
+        case TokenType::RETURN:
+            text = trim(text.substr(text.find("return") + 6));
+            if (splitCall(text, functionName, arguments)) {
+                compiled.callee = functionName;
+                return arguments;  // Tail call arguments
+            }
+            if (text.empty()) {
+                return {};
+            }
+            return {text};
+        case TokenType::ASSIGNMENT_FUNCTION_CALL:
+            compiled.returnTarget = trim(text.substr(0, text.find('=')));
+            splitCall(text.substr(text.find('=') + 1), functionName, arguments);
+            compiled.callee = functionName;
+            return arguments;
+        case TokenType::FUNCTION_CALL:
+            splitCall(text, functionName, arguments);
+            compiled.callee = functionName;
+            return arguments;
+        default:
+            return {};
+    }
+}
+
+
+// Closed interval of values a variable or expression can take
+struct Range {
+    Value low;
+    Value high;
+
+    static Range full() { return Range{INT64_MIN, INT64_MAX}; }
+    static Range point(Value value) { return Range{value, value}; }
+    bool contains(Value value) const { return low <= value && value <= high; }
+    Range join(const Range& other) const { return Range{std::min(low, other.low), std::max(high, other.high)}; }
+    bool operator==(const Range& other) const { return low == other.low && high == other.high; }
+};
+
+// Interval evaluation of compiled code. With annotate set, clears the checks the ranges make redundant.
+Range rangeOfExpression(CompiledExpression& compiled, const std::unordered_map<std::string, Range>& ranges, bool annotate) {
+    if (!compiled.error.empty()) {
+        return Range::full();
+    }
+    std::vector<Range> operands;
+    for (Instruction& instruction : compiled.code) {
+        if (instruction.kind == Instruction::PUSH_CONSTANT) {
+            operands.push_back(Range::point(instruction.constant));
+            continue;
+        }
+        if (instruction.kind == Instruction::PUSH_VARIABLE) {
+            auto it = ranges.find(instruction.variable);
+            operands.push_back(it != ranges.end() ? it->second : Range::point(0));  // Unset variables read as 0
+            continue;
+        }
+
+        Range right = operands.back(); operands.pop_back();
+        Range left = operands.back(); operands.pop_back();
+        // Bounds are computed in 128 bits so a 64-bit overflow shows up as an out of range bound
+        __int128 low, high;
+        bool divisorMayBeZero = false;
+        switch (instruction.op) {
+            case TokenType::PLUS:
+                low = (__int128)left.low + right.low;
+                high = (__int128)left.high + right.high;
+                break;
+            case TokenType::MINUS:
+                low = (__int128)left.low - right.high;
+                high = (__int128)left.high - right.low;
+                break;
+            case TokenType::MULTIPLY:
+            case TokenType::DIVIDE: {
+                divisorMayBeZero = instruction.op == TokenType::DIVIDE && right.contains(0);
+                if (divisorMayBeZero) {
+                    // |left / right| <= |left| for any nonzero right
+                    __int128 magnitude = std::max(-(__int128)left.low, (__int128)left.high);
+                    magnitude = std::max(magnitude, (__int128)0);
+                    // Only INT64_MIN / -1 leaves the range, so clamp instead of reporting overflow otherwise
+                    bool minByMinusOne = left.contains(INT64_MIN) && right.contains(-1);
+                    low = std::max(-magnitude, (__int128)INT64_MIN);
+                    high = minByMinusOne ? magnitude : std::min(magnitude, (__int128)INT64_MAX);
+                    break;
+                }
+                // Both operators are monotonic in each operand here, so the extremes are at the corners
+                __int128 corners[4];
+                Value lefts[2] = {left.low, left.high};
+                Value rights[2] = {right.low, right.high};
+                for (int i = 0; i < 4; ++i) {
+                    __int128 l = lefts[i / 2], r = rights[i % 2];
+                    corners[i] = instruction.op == TokenType::MULTIPLY ? l * r : l / r;
+                }
+                low = *std::min_element(corners, corners + 4);
+                high = *std::max_element(corners, corners + 4);
+                break;
+            }
+            default:
+                return Range::full();
+        }
+
+        bool mayOverflow = low < INT64_MIN || high > INT64_MAX;
+        if (annotate) {
+            instruction.checkOverflow = mayOverflow;
+            instruction.checkDivisionByZero = divisorMayBeZero;
+        }
+        // An out of range result throws at runtime, so only in-range values flow on
+        operands.push_back(mayOverflow ? Range::full() : Range{(Value)low, (Value)high});
+    }
+    return operands.back();
+}
+
+
 
 
 
 std::vector<std::string> printVariables;
 
-void parsePrint(const Token& token, std::unordered_map<std::string, int>& context, Interpreter& interpreter) {
+void parsePrint(const Token& token, std::unordered_map<std::string, Value>& context, Interpreter& interpreter) {
     // Split the token value into parts at the comma
     std::size_t commaPos = token.value.find(',');
     if (commaPos == std::string::npos) {
@@ -571,18 +1264,409 @@ void parsePrint(const Token& token, std::unordered_map<std::string, int>& contex
 }
 
 
-void parseFunctionCall(const Token& token, Interpreter& interpreter) {
-    // Extract the function name and arguments from the token value
-    size_t openParenthesisPos = token.value.find('(');
-    size_t closeParenthesisPos = token.value.find(')');
-    std::string functionName = token.value.substr(0, openParenthesisPos);
-    std::string arguments = token.value.substr(openParenthesisPos + 1, closeParenthesisPos - openParenthesisPos - 1);
+// Skips the block that belongs to the IF or ELSE token just executed
+void skipBlock(const std::vector<Token>& body, size_t& pc, int indentLevel) {
+    while (pc < body.size() && body[pc].indent_level > indentLevel) {
+        ++pc;
+    }
+}
+
+CompiledToken compileToken(const Token& token) {
+    CompiledToken compiled;
+    for (const std::string& source : expressionSources(token, compiled)) {
+        compiled.expressions.push_back(compileExpression(splitExpression(source)));
+    }
+    return compiled;
+}
+
+void countChecks(const CompiledToken& compiled, CheckStats& stats) {
+    for (const CompiledExpression& expression : compiled.expressions) {
+        if (!expression.error.empty()) {
+            ++stats.operandChecks;  // Kept: it reports the error when the expression runs
+            continue;
+        }
+        for (const Instruction& instruction : expression.code) {
+            if (instruction.kind != Instruction::APPLY_OPERATOR) {
+                continue;
+            }
+            ++stats.operandChecks;
+            ++stats.operandChecksRemoved;
+            ++stats.overflowChecks;
+            stats.overflowChecksRemoved += !instruction.checkOverflow;
+            if (instruction.op == TokenType::DIVIDE) {
+                ++stats.divisionChecks;
+                stats.divisionChecksRemoved += !instruction.checkDivisionByZero;
+            }
+        }
+    }
+}
 
-    // Create a FunctionCallNode with the function name and arguments
-    FunctionCallNode* node = new FunctionCallNode(functionName, arguments);
+CompiledToken& Interpreter::compiled(const Token& token) {
+    auto it = compiledTokens.find(&token);
+    if (it != compiledTokens.end()) {
+        return it->second;
+    }
+    // Not covered by range analysis, so every check stays on
+    CompiledToken& result = compiledTokens[&token] = compileToken(token);
+    countChecks(result, checkStats);
+    return result;
+}
+
+Value Interpreter::evaluate(const Token& token, size_t index, std::unordered_map<std::string, Value>& context) {
+    const CompiledToken& compiledToken = compiled(token);
+    if (index >= compiledToken.expressions.size()) {
+        throw std::runtime_error("Missing expression in: " + trim(token.value));
+    }
+    return runExpression(compiledToken.expressions[index], context);
+}
+
+std::vector<Value> Interpreter::evaluateArguments(const Token& token, std::unordered_map<std::string, Value>& context) {
+    return evaluateArguments(compiled(token), context);
+}
+
+std::vector<Value> Interpreter::evaluateArguments(const CompiledToken& compiledToken, std::unordered_map<std::string, Value>& context) {
+    std::vector<Value> values;
+    values.reserve(compiledToken.expressions.size());
+    for (const CompiledExpression& expression : compiledToken.expressions) {
+        values.push_back(runExpression(expression, context));
+    }
+    return values;
+}
+
+// Functions are all defined before the program runs and snapshot functions are only ever added,
+// so a resolved callee stays valid for the rest of the run
+FunctionDefNode* Interpreter::resolveCallee(CompiledToken& compiledToken) {
+    if (compiledToken.function == nullptr && !compiledToken.callee.empty()) {
+        compiledToken.function = findFunction(compiledToken.callee);
+    }
+    return compiledToken.function;
+}
+
+// Forward interval analysis. Control flow inside a scope only skips forward (if/else) or leaves it
+// (return, and a tail call starts over with fresh locals), so one pass in token order sees every
+// assignment that can reach a token. Tokens deeper than unconditionalIndent may be skipped, so their
+// assignments widen the variable's range instead of replacing it.
+void Interpreter::analyzeScope(const std::vector<const Token*>& tokens, const std::unordered_map<std::string, Value>& initialValues, const std::vector<std::string>& parameters, int unconditionalIndent) {
+    std::unordered_map<std::string, Range> ranges;
+    for (const auto& entry : initialValues) {
+        ranges[entry.first] = Range::point(entry.second);
+    }
+    for (const std::string& parameter : parameters) {
+        ranges[parameter] = Range::full();
+    }
+
+    for (const Token* token : tokens) {
+        CompiledToken& compiledToken = compiledTokens[token] = compileToken(*token);
+        Range assigned = Range::full();  // Function results are not tracked
+        for (CompiledExpression& expression : compiledToken.expressions) {
+            Range range = rangeOfExpression(expression, ranges, true);
+            if (token->type == TokenType::ASSIGN) {
+                assigned = range;
+            }
+        }
+        countChecks(compiledToken, checkStats);
+
+        if (token->type != TokenType::ASSIGN && token->type != TokenType::ASSIGNMENT_FUNCTION_CALL) {
+            continue;
+        }
+        std::string target = trim(token->value.substr(0, token->value.find('=')));
+        if (token->indent_level > unconditionalIndent) {
+            auto it = ranges.find(target);
+            Range current = it != ranges.end() ? it->second : Range::point(0);  // Unset variables read as 0
+            assigned = current.join(assigned);
+        }
+        ranges[target] = assigned;
+    }
+}
+
+void Interpreter::analyzeProgram(const std::vector<Token>& tokens, const std::unordered_map<std::string, Value>& context) {
+    // Only these top level tokens evaluate expressions; context holds any values restored from a snapshot
+    std::vector<const Token*> topLevel;
+    for (const Token& token : tokens) {
+        if (token.type == TokenType::ASSIGN || token.type == TokenType::ASSIGNMENT_FUNCTION_CALL || token.type == TokenType::FUNCTION_CALL) {
+            topLevel.push_back(&token);
+        }
+    }
+    analyzeScope(topLevel, context, {}, INT_MAX);  // Top level if blocks are not conditional yet, see parseIF()
+
+    for (const auto& entry : functions) {
+        analyzeFunction(*entry.second);
+    }
+}
+
+void Interpreter::analyzeFunction(const FunctionDefNode& function) {
+    std::vector<const Token*> body;
+    int unconditionalIndent = INT_MAX;
+    for (const Token& token : function.bodyTokens) {
+        body.push_back(&token);
+        unconditionalIndent = std::min(unconditionalIndent, token.indent_level);
+    }
+    analyzeScope(body, {}, function.parameters, unconditionalIndent);
+}
+
+void Interpreter::bindArguments(CallFrame& frame, FunctionDefNode* function, const std::vector<Value>& arguments) {
+    if (arguments.size() != function->parameters.size()) {
+        throw std::runtime_error("Function " + function->name + " expects " + std::to_string(function->parameters.size()) +
+                                 " arguments, got " + std::to_string(arguments.size()));
+    }
+    frame.function = function;
+    frame.pc = 0;
+    frame.locals.clear();
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        frame.locals[function->parameters[i]] = arguments[i];
+    }
+}
+
+void Interpreter::pushFrame(FunctionDefNode* function, const std::vector<Value>& arguments, const std::string& returnTarget) {
+    if (callStack.size() >= maxCallDepth) {
+        throw std::runtime_error("Maximum recursion depth of " + std::to_string(maxCallDepth) + " exceeded calling " + function->name);
+    }
+    callStack.push_back(CallFrame{nullptr, 0, {}, returnTarget});
+    bindArguments(callStack.back(), function, arguments);
+}
+
+Value Interpreter::callToken(const Token& token, std::unordered_map<std::string, Value>& context) {
+    CompiledToken& compiledToken = compiled(token);
+    if (compiledToken.callee.empty()) {
+        throw std::runtime_error("Invalid function call: " + trim(token.value));
+    }
+    FunctionDefNode* function = resolveCallee(compiledToken);
+    if (function == nullptr) {
+        throw std::runtime_error("Function not found: " + compiledToken.callee);
+    }
+
+    size_t baseDepth = callStack.size();
+    pushFrame(function, evaluateArguments(compiledToken, context), "");
+    return runCallStack(baseDepth);
+}
+
+void Interpreter::loadSnapshot(const std::string& path, std::unordered_map<std::string, Value>& context) {
+    snapshot = std::make_unique<Snapshot>(path);
+
+    // Every variable access goes through the context map, so the slots are copied in up front
+    const SnapshotVariable* variables = snapshot->variables();
+    uint64_t variableCount = snapshot->header().variableCount;
+    context.reserve(context.size() + variableCount);
+    for (uint64_t i = 0; i < variableCount; ++i) {
+        context[snapshot->str(variables[i].name)] = variables[i].value;
+    }
+}
+
+void Interpreter::saveSnapshot(const std::string& path, const std::unordered_map<std::string, Value>& context) {
+    // Pull in anything still only in the old snapshot so it is carried forward
+    if (snapshot) {
+        const SnapshotFunction* stored = snapshot->functions();
+        for (uint64_t i = 0; i < snapshot->header().functionCount; ++i) {
+            findFunction(snapshot->str(stored[i].name));
+        }
+    }
+
+    // Call temporaries are scratch values of the statement that made them, not program state
+    std::vector<std::pair<std::string, Value>> variables;
+    for (const auto& entry : context) {
+        if (!isTemporary(entry.first)) {
+            variables.push_back(entry);
+        }
+    }
+
+    std::vector<const FunctionDefNode*> sortedFunctions;
+    size_t parameterCount = 0, tokenCount = 0;
+    for (const auto& entry : functions) {
+        sortedFunctions.push_back(entry.second.get());
+        parameterCount += entry.second->parameters.size();
+        tokenCount += entry.second->bodyTokens.size();
+    }
+    std::sort(sortedFunctions.begin(), sortedFunctions.end(),
+              [](const FunctionDefNode* a, const FunctionDefNode* b) { return a->name < b->name; });
+
+    // Fixed-size tables first, then the string blob they point into
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.variableCount = variables.size();
+    header.variablesOffset = sizeof(SnapshotHeader);
+    header.functionCount = sortedFunctions.size();
+    header.functionsOffset = header.variablesOffset + header.variableCount * sizeof(SnapshotVariable);
+    uint64_t parametersOffset = header.functionsOffset + header.functionCount * sizeof(SnapshotFunction);
+    uint64_t tokensOffset = parametersOffset + parameterCount * sizeof(SnapshotString);
+    uint64_t stringsOffset = tokensOffset + tokenCount * sizeof(SnapshotToken);
+
+    std::vector<char> file(stringsOffset);
+    auto addString = [&](const std::string& text) {
+        SnapshotString ref{file.size(), text.size()};
+        file.insert(file.end(), text.begin(), text.end());
+        return ref;
+    };
+
+    std::vector<SnapshotVariable> variableTable;
+    for (const auto& entry : variables) {
+        variableTable.push_back(SnapshotVariable{addString(entry.first), entry.second});
+    }
+    std::vector<SnapshotFunction> functionTable;
+    std::vector<SnapshotString> parameterTable;
+    std::vector<SnapshotToken> tokenTable;
+    for (const FunctionDefNode* function : sortedFunctions) {
+        SnapshotFunction record{addString(function->name), function->parameters.size(),
+                                parametersOffset + parameterTable.size() * sizeof(SnapshotString),
+                                function->bodyTokens.size(), tokensOffset + tokenTable.size() * sizeof(SnapshotToken)};
+        functionTable.push_back(record);
+        for (const std::string& parameter : function->parameters) {
+            parameterTable.push_back(addString(parameter));
+        }
+        for (const Token& token : function->bodyTokens) {
+            tokenTable.push_back(SnapshotToken{static_cast<int32_t>(token.type), token.indent_level, token.line, token.column, addString(token.value)});
+        }
+    }
+    header.fileSize = file.size();
+
+    // The tables were sized up front; copy them into their slots now that the strings are placed
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + header.variablesOffset, variableTable.data(), variableTable.size() * sizeof(SnapshotVariable));
+    std::memcpy(file.data() + header.functionsOffset, functionTable.data(), functionTable.size() * sizeof(SnapshotFunction));
+    std::memcpy(file.data() + parametersOffset, parameterTable.data(), parameterTable.size() * sizeof(SnapshotString));
+    std::memcpy(file.data() + tokensOffset, tokenTable.data(), tokenTable.size() * sizeof(SnapshotToken));
+
+    // Write a new file and rename it over path, so a process that has the old snapshot mapped
+    // (this one included) keeps reading the old file instead of seeing it truncated
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+    out.write(file.data(), file.size());
+    out.close();
+    if (!out) {
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Could not write snapshot " + path);
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Could not replace snapshot " + path);
+    }
+}
+
+// Charges a sample to token, which was just executed by function in the frame at callStack[depth - 1]
+// (depth 0 means a top level statement). Frames below it are unchanged by that token, so their pc
+// still points just past the call they are waiting on.
+void Interpreter::recordSample(const FunctionDefNode* function, const Token& token, size_t depth) {
+    Profiler::Sample& sample = profiler->beginSample();
+    sample.depth = 0;
+    sample.lines[sample.depth] = depth == 0 ? token.line : (currentStatement ? currentStatement->line : 0);
+    sample.functions[sample.depth++] = nullptr;
+    if (depth == 0) {
+        sample.truncated = false;
+        profiler->commitSample();
+        return;
+    }
+
+    // Room is kept for the top level and the innermost entry
+    size_t callers = depth - 1;
+    size_t first = 0;
+    sample.truncated = callers > Profiler::kMaxSampleDepth - 2;
+    if (sample.truncated) {
+        first = callers - (Profiler::kMaxSampleDepth - 2);
+    }
+    for (size_t i = first; i < callers; ++i) {
+        const CallFrame& frame = callStack[i];
+        size_t pc = frame.pc > 0 ? frame.pc - 1 : 0;
+        sample.lines[sample.depth] = pc < frame.function->bodyTokens.size() ? frame.function->bodyTokens[pc].line : 0;
+        sample.functions[sample.depth++] = frame.function;
+    }
+    sample.lines[sample.depth] = token.line;
+    sample.functions[sample.depth++] = function;
+    profiler->commitSample();
+}
+
+// Runs frames until the stack unwinds back to baseDepth. Script calls push a frame and
+// continue the loop instead of recursing in C++, and "return f(...)" reuses the current frame.
+Value Interpreter::runCallStack(size_t baseDepth) {
+    Value result = 0;
+
+    // Pops the top frame and hands value to the caller's return target
+    auto returnFromFrame = [&](Value value) {
+        std::string returnTarget = callStack.back().returnTarget;
+        callStack.pop_back();
+        if (callStack.size() > baseDepth) {
+            if (!returnTarget.empty()) {
+                callStack.back().locals[returnTarget] = value;
+            }
+        } else {
+            result = value;
+        }
+    };
+
+    while (callStack.size() > baseDepth) {
+        CallFrame& frame = callStack.back();
+        const std::vector<Token>& body = frame.function->bodyTokens;
+        if (frame.pc >= body.size()) {
+            returnFromFrame(0);  // Fell off the end of the body
+            continue;
+        }
 
-    // Push the FunctionCallNode onto the function call stack
-    interpreter.functionCallStack.push(node);
+        // Tail calls rebind frame and calls push past it, so remember who is running this token
+        const FunctionDefNode* executing = frame.function;
+        size_t depth = callStack.size();
+        const Token& token = body[frame.pc++];
+        switch (token.type) {
+            case TokenType::ASSIGN:
+                parseAssignment(token, frame.locals, *this);
+                break;
+            case TokenType::PRINT:
+                parsePrint(token, frame.locals, *this);
+                break;
+            case TokenType::ASSIGNMENT_FUNCTION_CALL:
+            case TokenType::FUNCTION_CALL: {
+                CompiledToken& compiledToken = compiled(token);
+                FunctionDefNode* function = resolveCallee(compiledToken);
+                if (function == nullptr) {
+                    throw std::runtime_error("Function not found in call: " + trim(token.value));
+                }
+                // frame is invalidated once the new frame is pushed
+                pushFrame(function, evaluateArguments(compiledToken, frame.locals), compiledToken.returnTarget);
+                break;
+            }
+            case TokenType::RETURN: {
+                CompiledToken& compiledToken = compiled(token);
+                if (!compiledToken.callee.empty()) {
+                    FunctionDefNode* function = resolveCallee(compiledToken);
+                    if (function == nullptr) {
+                        throw std::runtime_error("Function not found in return: " + trim(token.value));
+                    }
+                    // Tail call: evaluate the arguments, then reuse this frame and keep its return target
+                    bindArguments(frame, function, evaluateArguments(compiledToken, frame.locals));
+                    break;
+                }
+                if (compiledToken.expressions.empty()) {
+                    returnFromFrame(0);
+                    break;
+                }
+                returnFromFrame(runExpression(compiledToken.expressions[0], frame.locals));
+                break;
+            }
+            case TokenType::IF:
+                if (!evaluateCondition(token, frame.locals, *this)) {
+                    skipBlock(body, frame.pc, token.indent_level);
+                    if (frame.pc < body.size() && body[frame.pc].type == TokenType::ELSE && body[frame.pc].indent_level == token.indent_level) {
+                        ++frame.pc;  // Run the else block instead
+                    }
+                }
+                break;
+            case TokenType::ELSE:
+                skipBlock(body, frame.pc, token.indent_level);  // Reached only after the if block ran
+                break;
+            default:
+                std::stringstream ss;
+                ss << "Unexpected token type in function " << frame.function->name << ": " << static_cast<int>(token.type);
+                throw std::runtime_error(ss.str());
+        }
+        if (profiler != nullptr && profiler->sampleDue()) {
+            recordSample(executing, token, depth);
+        }
+    }
+    return result;
+}
+
+
+void parseFunctionCall(const Token& token, std::unordered_map<std::string, Value>& context, Interpreter& interpreter) {
+    // Run the call for its side effects and discard the result
+    interpreter.callToken(token, context);
 }
 
 void parseReturn(const Token& token, Interpreter& interpreter) {
@@ -593,17 +1677,12 @@ void parseReturn(const Token& token, Interpreter& interpreter) {
     interpreter.setReturnVariable(returnVariable);
 }
 
-void parseAssignmentFunctionCall(const Token& token, std::unordered_map<std::string, int>& context, Interpreter& interpreter) {
-    // Extract the variable name, function name, and arguments from the token value
-    size_t equalsPos = token.value.find('=');
-    std::string variableName = token.value.substr(0, equalsPos);
-    std::string functionCall = token.value.substr(equalsPos + 1);
-
+void parseAssignmentFunctionCall(const Token& token, std::unordered_map<std::string, Value>& context, Interpreter& interpreter) {
     // Call the function and get the return value
-    int returnValue = interpreter.callFunction(functionCall);
+    Value returnValue = interpreter.callToken(token, context);
 
-    // Assign the return value to the variable in the context
-    context[variableName] = returnValue;
+    // Assign the return value to the variable the compiled token recorded
+    context[interpreter.compiled(token).returnTarget] = returnValue;
 }
 
 
@@ -613,10 +1692,11 @@ void parseIF(const Token& token, Interpreter& interpreter) {
     // std::cout << "parseif" << conditionalStatment << std::endl;
 
 }
-void parseProgram(const std::vector<Token>& tokens, std::unordered_map<std::string, int>& context, std::vector<Token>& printStatements, Interpreter& interpreter) {
+void parseProgram(const std::vector<Token>& tokens, std::unordered_map<std::string, Value>& context, std::vector<Token>& printStatements, Interpreter& interpreter) {
     // std::cout << "*************************" << "\n";
     size_t i = 0;
     for (const Token& token : tokens) {
+        interpreter.beginStatement(token);
         switch (token.type) {
             case TokenType::ASSIGN:
                 parseAssignment(token, context, interpreter);
@@ -640,13 +1720,13 @@ void parseProgram(const std::vector<Token>& tokens, std::unordered_map<std::stri
                 }
                 break;
             case TokenType::FUNCTION_CALL:
-                parseFunctionCall(token, interpreter);
+                parseFunctionCall(token, context, interpreter);
                 break;
             case TokenType::RETURN:
                 parseReturn(token, interpreter);
                 break;
             case TokenType::ASSIGNMENT_FUNCTION_CALL:
-               // parseAssignmentFunctionCall(token, context, interpreter);
+                parseAssignmentFunctionCall(token, context, interpreter);
                 break;
              case TokenType::IF:
                 parseIF(token,interpreter);
@@ -660,20 +1740,51 @@ void parseProgram(const std::vector<Token>& tokens, std::unordered_map<std::stri
                 ss << "Unexpected token type in parseProgram: " << static_cast<int>(token.type);
                 throw std::runtime_error(ss.str());
         }
+        interpreter.endStatement(token);
     }
     //std::cout << "*************************" << "\n";
 }
 
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>\n";
+    std::string filename;
+    size_t maxCallDepth = 0;
+    bool profile = false;
+    bool checkStats = false;
+    std::string loadSnapshotPath;
+    std::string saveSnapshotPath;
+    bool badArgument = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-depth" && i + 1 < argc) {
+            // Digits only, and short enough that stoul cannot throw
+            std::string depth = argv[++i];
+            if (depth.empty() || depth.size() > 9 || depth.find_first_not_of("0123456789") != std::string::npos || std::stoul(depth) == 0) {
+                std::cerr << "Invalid --max-depth value: " << depth << "\n";
+                badArgument = true;
+            } else {
+                maxCallDepth = std::stoul(depth);
+            }
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--check-stats") {
+            checkStats = true;
+        } else if (arg == "--load-snapshot" && i + 1 < argc) {
+            loadSnapshotPath = argv[++i];
+        } else if (arg == "--save-snapshot" && i + 1 < argc) {
+            saveSnapshotPath = argv[++i];
+        } else {
+            filename = arg;
+        }
+    }
+    if (filename.empty() || badArgument) {
+        std::cerr << "Usage: " << argv[0] << " [--max-depth N] [--profile] [--load-snapshot FILE] [--save-snapshot FILE] [--check-stats] <filename>\n";
         return 1;
     }
 
-    std::ifstream file(argv[1]);
+    std::ifstream file(filename);
     if (!file) {
-        std::cerr << "Could not open file " << argv[1] << "\n";
+        std::cerr << "Could not open file " << filename << "\n";
         return 1;
     }
     
@@ -682,13 +1793,55 @@ int main(int argc, char* argv[]) {
     std::string input = buffer.str();
 
     Interpreter interpreter;  // Create an Interpreter object
-    auto tokens = tokenize(input, interpreter);  // Pass the Interpreter object to the tokenize function
+    if (maxCallDepth > 0) {
+        interpreter.setMaxCallDepth(maxCallDepth);
+    }
+
+    // Asks for a sample every millisecond of CPU time, best effort: ITIMER_PROF fires at the kernel
+    // tick, so expect around 250 samples a second. Results go to <filename>.lines and <filename>.folded
+    Profiler profiler;
+    if (profile) {
+        interpreter.setProfiler(&profiler);
+        profiler.start(1000);
+    }
     
-    std::unordered_map<std::string, int> context;  // This will hold variable values
+    std::unordered_map<std::string, Value> context;  // This will hold variable values
     std::vector<Token> printStatements; // Store print statements to handle after all evaluations
 
-    // Parse and evaluate all tokens, store print statements for later
-    parseProgram(tokens, context, printStatements, interpreter);  // Pass the Interpreter object to the parseProgram function
+    int status = 0;
+    try {
+        // Start from the functions and variables a previous run saved
+        if (!loadSnapshotPath.empty()) {
+            interpreter.loadSnapshot(loadSnapshotPath, context);
+        }
+
+        auto tokens = tokenize(input, interpreter);  // Pass the Interpreter object to the tokenize function
+        interpreter.analyzeProgram(tokens, context);
+
+        // Parse and evaluate all tokens, store print statements for later
+        parseProgram(tokens, context, printStatements, interpreter);  // Pass the Interpreter object to the parseProgram function
+
+        if (!saveSnapshotPath.empty()) {
+            interpreter.saveSnapshot(saveSnapshotPath, context);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        status = 1;
+    }
+
+    if (profile) {
+        profiler.stop();
+        profiler.writeReport(filename);
+    }
+    if (checkStats) {
+        const CheckStats& stats = interpreter.getCheckStats();
+        std::cerr << "Range analysis: removed " << stats.divisionChecksRemoved << "/" << stats.divisionChecks << " division by zero checks, "
+                  << stats.operandChecksRemoved << "/" << stats.operandChecks << " operand count checks; "
+                  << stats.overflowChecks - stats.overflowChecksRemoved << "/" << stats.overflowChecks << " operations need overflow checks\n";
+    }
+    if (status != 0) {
+        return status;
+    }
 
        // Optionally print all context variables
     //std::cout << "Final Variable Values:\n";